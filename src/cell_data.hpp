@@ -9,6 +9,8 @@
 
 namespace godot {
 
+struct TileInfoCells;
+
 struct CellData {
   int64_t cell_id;
   RID canvas_rid;
@@ -20,6 +22,28 @@ struct CellData {
 
   Ref<Texture2D> texture;
   TypedArray<RID> physics_bodies_rid;
+
+  TileInfoCells *info_cells;
+  Rect2i collision_grid_rect;
+
+  bool navigation_solid;
+  Vector2i navigation_point;
+};
+
+struct TilePolygon {
+  int32_t physics_layer;
+  uint32_t collision_layer;
+  std::vector<Vector2> points;
+};
+
+struct TileInfoCells {
+  std::unordered_map<int64_t, CellData*> cells;
+  TileData *tile_data;
+  Array render_state;
+  Array physics_state;
+
+  std::vector<TilePolygon> collision_polygons;
+  Rect2 collision_rect;
 };
 
 }
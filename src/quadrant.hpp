@@ -24,6 +24,9 @@ struct Quadrant {
   RID canvas_item;
   TileInfo tile_info;
   TileData *tile_data;
+  Rect2 bounds;
+  uint32_t edit_count;
+  uint32_t merge_cooldown;
 };
 
 }
@@ -8,15 +8,38 @@
 #include <godot_cpp/classes/material.hpp>
 #include <godot_cpp/classes/scene_tree.hpp>
 
+#include <algorithm>
+
 using namespace godot;
 
+static int64_t _get_collision_grid_key(const int32_t x, const int32_t y) {
+  return int64_t((uint64_t(uint32_t(x)) << 32) | uint32_t(y));
+}
+
+static Vector2i _get_collision_grid_point(const int64_t key) {
+  return Vector2i(int32_t(uint32_t(uint64_t(key) >> 32)), int32_t(uint32_t(key)));
+}
+
 void TileMapper::_bind_methods() {
   ClassDB::bind_method(D_METHOD("add_cell", "coords", "source_id", "atlas_coords", "alternative_tile_id"), &TileMapper::add_cell, DEFVAL(Vector2i()), DEFVAL(0));
   ClassDB::bind_method(D_METHOD("destroy_cell", "cell_id"), &TileMapper::destroy_cell);
   ClassDB::bind_method(D_METHOD("clear_cells"), &TileMapper::clear_cells);
+  ClassDB::bind_method(D_METHOD("fill_rect", "rect", "origin", "cell_size", "source_id", "atlas_coords", "alternative_tile_id"), &TileMapper::fill_rect, DEFVAL(Vector2i()), DEFVAL(0));
+  ClassDB::bind_method(D_METHOD("fill_from_image", "image", "origin", "cell_size", "palette_to_tile"), &TileMapper::fill_from_image);
+  ClassDB::bind_method(D_METHOD("fill_from_bytes", "data", "width", "origin", "cell_size", "palette_to_tile"), &TileMapper::fill_from_bytes);
   ClassDB::bind_method(D_METHOD("is_cell_id_valid", "cell_id"), &TileMapper::is_cell_id_valid);
   ClassDB::bind_method(D_METHOD("get_used_tile_ids"), &TileMapper::get_used_tile_ids);
   ClassDB::bind_method(D_METHOD("get_cell_values"), &TileMapper::get_cell_values);
+  ClassDB::bind_method(D_METHOD("_on_tile_set_changed"), &TileMapper::_on_tile_set_changed);
+
+  ClassDB::bind_method(D_METHOD("raycast", "from", "to", "layer_mask"), &TileMapper::raycast, DEFVAL(0xFFFFFFFF));
+  ClassDB::bind_method(D_METHOD("has_line_of_sight", "from", "to", "layer_mask"), &TileMapper::has_line_of_sight, DEFVAL(0xFFFFFFFF));
+  ClassDB::bind_method(D_METHOD("raycast_batch", "segments", "layer_mask"), &TileMapper::raycast_batch, DEFVAL(0xFFFFFFFF));
+  ClassDB::bind_method(D_METHOD("has_line_of_sight_batch", "segments", "layer_mask"), &TileMapper::has_line_of_sight_batch, DEFVAL(0xFFFFFFFF));
+  ClassDB::bind_method(D_METHOD("sync_navigation_grid"), &TileMapper::sync_navigation_grid);
+#ifdef TILE_MAPPER_TRACING
+  ClassDB::bind_method(D_METHOD("dump_trace", "path"), &TileMapper::dump_trace);
+#endif
 
   ClassDB::bind_method(D_METHOD("set_tile_set", "new_tile_set"), &TileMapper::set_tile_set);
   ClassDB::bind_method(D_METHOD("get_tile_set"), &TileMapper::get_tile_set);
@@ -30,22 +53,60 @@ void TileMapper::_bind_methods() {
   ClassDB::bind_method(D_METHOD("get_quadrant_size"), &TileMapper::get_quadrant_size);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "quadrant_size", PROPERTY_HINT_RANGE, "1,1028,1,or_greater"), "set_quadrant_size", "get_quadrant_size");
 
+  ClassDB::bind_method(D_METHOD("set_adaptive_quadrants", "new_adaptive_quadrants"), &TileMapper::set_adaptive_quadrants);
+  ClassDB::bind_method(D_METHOD("get_adaptive_quadrants"), &TileMapper::get_adaptive_quadrants);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "adaptive_quadrants"), "set_adaptive_quadrants", "get_adaptive_quadrants");
+
   ClassDB::bind_method(D_METHOD("set_collision_visibility", "new_collision_visibility"), &TileMapper::set_collision_visibility);
   ClassDB::bind_method(D_METHOD("get_collision_visibility"), &TileMapper::get_collision_visibility);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_visibility", PROPERTY_HINT_ENUM, "Default,Always,None"), "set_collision_visibility", "get_collision_visibility");
+
+  ClassDB::bind_method(D_METHOD("set_collision_grid_size", "new_collision_grid_size"), &TileMapper::set_collision_grid_size);
+  ClassDB::bind_method(D_METHOD("get_collision_grid_size"), &TileMapper::get_collision_grid_size);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_grid_size", PROPERTY_HINT_RANGE, "1,1028,1,or_greater"), "set_collision_grid_size", "get_collision_grid_size");
+
+  ClassDB::bind_method(D_METHOD("set_navigation_grid", "new_navigation_grid"), &TileMapper::set_navigation_grid);
+  ClassDB::bind_method(D_METHOD("get_navigation_grid"), &TileMapper::get_navigation_grid);
+
+  ClassDB::bind_method(D_METHOD("set_navigation_physics_layer", "new_navigation_physics_layer"), &TileMapper::set_navigation_physics_layer);
+  ClassDB::bind_method(D_METHOD("get_navigation_physics_layer"), &TileMapper::get_navigation_physics_layer);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "navigation_physics_layer", PROPERTY_HINT_RANGE, "0,32,1,or_greater"), "set_navigation_physics_layer", "get_navigation_physics_layer");
 }
 
 TileMapper::TileMapper() {
   collision_type = PhysicsServer2D::BODY_MODE_STATIC;
   quadrant_size = 64;
+  adaptive_quadrants = false;
+  physics_bodies_need_rebuild = false;
   collision_visibility = COLLISION_VISIBILITY_DEFAULT;
+  collision_grid_size = 64;
+  navigation_physics_layer = 0;
   index = 1;
   quadrants = {};
   tiles = {};
+  tile_info_cells = {};
+  collision_grid = {};
+  collision_grid_bounds = Rect2i();
+  navigation_solid_counts = {};
 }
 
 TileMapper::~TileMapper() {
-  clear_cells();
+  _free_all_cells();
+}
+
+void TileMapper::_notification(int what) {
+  switch (what) {
+    case NOTIFICATION_ENTER_TREE:
+      if (physics_bodies_need_rebuild)
+        _rebuild_physics_bodies();
+      break;
+    case NOTIFICATION_PROCESS:
+      if (adaptive_quadrants && !active_quadrants.empty())
+        _compact_quadrants();
+      break;
+    default:
+      break;
+  }
 }
 
 Ref<TileSetAtlasSource> TileMapper::_get_atlas_source(const int32_t source_id) const {
@@ -71,18 +132,71 @@ Rect2i TileMapper::_get_texture_region_from_cell_data(CellData *cell_data) const
 return _get_texture_region_from_atlas_source(cell_data->tile_info.source_id, Vector2i(cell_data->tile_info.x, cell_data->tile_info.y));
 }
 
+Vector2 TileMapper::_get_tile_shape_offset(const TileInfo &tile_info) const {
+  return -Vector2(_get_texture_region_from_atlas_source(tile_info.source_id, Vector2i(tile_info.x, tile_info.y)).get_size()) / 2;
+}
+
+TileData *TileMapper::_get_tile_data_from_tile_info(const TileInfo &tile_info) const {
+  Ref<TileSetAtlasSource> source = _get_atlas_source(tile_info.source_id);
+  Vector2i atlas_coords = Vector2i(tile_info.x, tile_info.y);
+
+  if (source.is_null() || !source->has_tile(atlas_coords) || !source->has_alternative_tile(atlas_coords, tile_info.alternative_tile_id))
+    return nullptr;
+  return source->get_tile_data(atlas_coords, tile_info.alternative_tile_id);
+}
+
+Array TileMapper::_get_tile_render_state(const TileInfo &tile_info) const {
+  Array state = {};
+  TileData *tile_data = _get_tile_data_from_tile_info(tile_info);
+  if (tile_data == nullptr)
+    return state;
+
+  state.append(_get_texture_from_source_id(tile_info.source_id));
+  state.append(_get_texture_region_from_atlas_source(tile_info.source_id, Vector2i(tile_info.x, tile_info.y)));
+  state.append(tile_data->get_texture_origin());
+  state.append(tile_data->get_modulate());
+  state.append(tile_data->get_material());
+  state.append(tile_data->get_z_index());
+  state.append(tile_data->get_transpose());
+  return state;
+}
+
+Array TileMapper::_get_tile_physics_state(const TileInfo &tile_info) const {
+  Array state = {};
+  TileData *tile_data = _get_tile_data_from_tile_info(tile_info);
+  if (tile_data == nullptr)
+    return state;
+
+  state.append(_get_texture_region_from_atlas_source(tile_info.source_id, Vector2i(tile_info.x, tile_info.y)).get_size());
+  for (int32_t layer = 0; layer < tile_set->get_physics_layers_count(); layer++) {
+    state.append(tile_set->get_physics_layer_collision_layer(layer));
+    state.append(tile_set->get_physics_layer_collision_mask(layer));
+    state.append(tile_set->get_physics_layer_physics_material(layer));
+    state.append(tile_data->get_constant_linear_velocity(layer));
+    state.append(tile_data->get_constant_angular_velocity(layer));
+
+    for (int32_t polygon_index = 0; polygon_index < tile_data->get_collision_polygons_count(layer); polygon_index++) {
+      state.append(tile_data->get_collision_polygon_points(layer, polygon_index));
+      state.append(tile_data->is_collision_polygon_one_way(layer, polygon_index));
+      state.append(tile_data->get_collision_polygon_one_way_margin(layer, polygon_index));
+    }
+  }
+  return state;
+}
+
 
 RID TileMapper::_create_shape_for_cell_layer_polygon_index(CellData *cell_data, int32_t layer, int32_t polygon_index) const {
   PackedVector2Array points = cell_data->tile_data->get_collision_polygon_points(layer, polygon_index);
   if (points.size() <= 2)
     return RID();
 
-  RID shape = PhysicsServer2D::get_singleton()->convex_polygon_shape_create();
-  PhysicsServer2D::get_singleton()->shape_set_data(shape, points);
+  RID shape = TRACE_SERVER(PhysicsServer2D::get_singleton())->convex_polygon_shape_create();
+  TRACE_SERVER(PhysicsServer2D::get_singleton())->shape_set_data(shape, points);
   return shape;
 }
 
 RID TileMapper::_create_cell_body_for_layer(CellData *cell_data, int32_t layer) const {
+  TRACE_ZONE("_create_cell_body_for_layer");
   std::vector<RID> shapes = {};
   std::vector<ShapeData> shape_datas = {};
 
@@ -97,35 +211,34 @@ RID TileMapper::_create_cell_body_for_layer(CellData *cell_data, int32_t layer)
     shapes.push_back(shape);
     shape_datas.push_back(shape_data);
   }
-  UtilityFunctions::print(shapes.size());
   if (shapes.empty()) {
     return RID();
   }
 
   Ref<PhysicsMaterial> material = tile_set->get_physics_layer_physics_material(layer);
-  RID body = PhysicsServer2D::get_singleton()->body_create();
-  Size2i cell_size = _get_texture_region_from_cell_data(cell_data).get_size();
+  RID body = TRACE_SERVER(PhysicsServer2D::get_singleton())->body_create();
+  Transform2D shape_transform = Transform2D(0, _get_tile_shape_offset(cell_data->tile_info));
   Ref<World2D> world_2d = get_world_2d();
   PhysicsServer2D *physics_server2d = PhysicsServer2D::get_singleton();
 
-  physics_server2d->body_set_mode(body, collision_type);
-  physics_server2d->body_set_space(body, get_world_2d()->get_space());
-  physics_server2d->body_set_state(body, PhysicsServer2D::BODY_STATE_TRANSFORM, cell_data->transform);
-  physics_server2d->body_set_collision_layer(body, tile_set->get_physics_layer_collision_layer(layer));
-  physics_server2d->body_set_collision_mask(body, tile_set->get_physics_layer_collision_mask(layer));
-  physics_server2d->body_set_constant_force(body, cell_data->tile_data->get_constant_linear_velocity(layer));
-  physics_server2d->body_set_constant_torque(body, cell_data->tile_data->get_constant_angular_velocity(layer));
+  TRACE_SERVER(physics_server2d)->body_set_mode(body, collision_type);
+  TRACE_SERVER(physics_server2d)->body_set_space(body, get_world_2d()->get_space());
+  TRACE_SERVER(physics_server2d)->body_set_state(body, PhysicsServer2D::BODY_STATE_TRANSFORM, cell_data->transform);
+  TRACE_SERVER(physics_server2d)->body_set_collision_layer(body, tile_set->get_physics_layer_collision_layer(layer));
+  TRACE_SERVER(physics_server2d)->body_set_collision_mask(body, tile_set->get_physics_layer_collision_mask(layer));
+  TRACE_SERVER(physics_server2d)->body_set_constant_force(body, cell_data->tile_data->get_constant_linear_velocity(layer));
+  TRACE_SERVER(physics_server2d)->body_set_constant_torque(body, cell_data->tile_data->get_constant_angular_velocity(layer));
 
   for (int32_t i = 0; i < shapes.size(); i++) {
     RID shape = shapes[i];
     ShapeData shape_data = shape_datas[i];
-    physics_server2d->body_add_shape(body, shape, Transform2D(0, -cell_size / 2));
-    physics_server2d->body_set_shape_as_one_way_collision(body, i, shape_data.one_way, shape_data.margin);
+    TRACE_SERVER(physics_server2d)->body_add_shape(body, shape, shape_transform);
+    TRACE_SERVER(physics_server2d)->body_set_shape_as_one_way_collision(body, i, shape_data.one_way, shape_data.margin);
   }
 
   if (material.is_valid()) {
-    physics_server2d->body_set_param(body, PhysicsServer2D::BODY_PARAM_BOUNCE, material->get_bounce());
-    physics_server2d->body_set_param(body, PhysicsServer2D::BODY_PARAM_FRICTION, material->get_friction());
+    TRACE_SERVER(physics_server2d)->body_set_param(body, PhysicsServer2D::BODY_PARAM_BOUNCE, material->get_bounce());
+    TRACE_SERVER(physics_server2d)->body_set_param(body, PhysicsServer2D::BODY_PARAM_FRICTION, material->get_friction());
   }
 
   return body;
@@ -133,6 +246,9 @@ RID TileMapper::_create_cell_body_for_layer(CellData *cell_data, int32_t layer)
 
 TypedArray<RID> TileMapper::_create_physics_bodies_for_cell(CellData *cell_data) const {
   TypedArray<RID> bodies = {};
+  // Bodies need the World2D space, cells created or changed outside the tree get theirs on NOTIFICATION_ENTER_TREE.
+  if (tile_set.is_null() || cell_data->tile_data == nullptr || !is_inside_tree())
+    return bodies;
 
   for (int32_t layer = 0; layer < tile_set->get_physics_layers_count(); layer++) {
     RID body = _create_cell_body_for_layer(cell_data, layer);
@@ -143,21 +259,56 @@ TypedArray<RID> TileMapper::_create_physics_bodies_for_cell(CellData *cell_data)
   return bodies;
 }
 
+void TileMapper::_free_cell_physics_bodies(CellData *cell_data) {
+  PhysicsServer2D *physics_server2d = PhysicsServer2D::get_singleton();
+  std::vector<RID> shapes = {};
+
+  // Bodies are freed before their shapes so the shapes aren't removed while the body still updates the broadphase.
+  for (int64_t i = 0; i < cell_data->physics_bodies_rid.size(); i++) {
+    RID body = cell_data->physics_bodies_rid[i];
+    int32_t shape_count = TRACE_SERVER(physics_server2d)->body_get_shape_count(body);
+
+    for (int32_t shape_index = 0; shape_index < shape_count; shape_index++) {
+      shapes.push_back(TRACE_SERVER(physics_server2d)->body_get_shape(body, shape_index));
+    }
+
+    TRACE_SERVER(physics_server2d)->free_rid(body);
+  }
+
+  for (const RID &shape: shapes)
+    TRACE_SERVER(physics_server2d)->free_rid(shape);
+  cell_data->physics_bodies_rid.clear();
+}
+
+void TileMapper::_rebuild_physics_bodies() {
+  physics_bodies_need_rebuild = false;
+
+  for (const std::pair<const int64_t, CellData*> &iterator: tiles) {
+    _free_cell_physics_bodies(iterator.second);
+    iterator.second->physics_bodies_rid = _create_physics_bodies_for_cell(iterator.second);
+  }
+}
+
 void TileMapper::_draw_quadrant(Quadrant *quadrant) {
+  TRACE_ZONE_NAMED(trace_zone, "_draw_quadrant");
+  TRACE_ZONE_CELLS(trace_zone, quadrant->cells.size());
   const bool draw_debug_shapes = _should_draw_debug_shapes();
-  RenderingServer::get_singleton()->canvas_item_clear(quadrant->canvas_item);
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_clear(quadrant->canvas_item);
   for (std::pair<int64_t, CellData*> iterator: quadrant->cells) {
     _draw_quadrant_cell(iterator.second, quadrant);
   }
 }
 
 void TileMapper::_draw_quadrant_cell(CellData *cell_data, Quadrant *quadrant) {
+  if (cell_data->tile_data == nullptr || cell_data->texture.is_null())
+    return;
+
   Rect2i size_rect = _get_texture_region_from_cell_data(cell_data);
   Rect2i texture_rect = Rect2i((size_rect.get_position() + cell_data->tile_data->get_texture_origin() - size_rect.size), size_rect.size);
 
   RenderingServer *rendering_server = RenderingServer::get_singleton();
-  rendering_server->canvas_item_add_set_transform(quadrant->canvas_item, cell_data->transform);
-  rendering_server->canvas_item_add_texture_rect_region(quadrant->canvas_item,
+  TRACE_SERVER(rendering_server)->canvas_item_add_set_transform(quadrant->canvas_item, cell_data->transform);
+  TRACE_SERVER(rendering_server)->canvas_item_add_texture_rect_region(quadrant->canvas_item,
       texture_rect,
       cell_data->texture->get_rid(),
       size_rect,
@@ -172,15 +323,31 @@ void TileMapper::_draw_quadrant_cell(CellData *cell_data, Quadrant *quadrant) {
 Quadrant *TileMapper::_create_new_quadrant() const {
   Quadrant *new_quadrant = memnew(Quadrant);
   Ref<Material> material = get_material();
-  new_quadrant->canvas_item = RenderingServer::get_singleton()->canvas_item_create();
-  RenderingServer::get_singleton()->canvas_item_set_parent(new_quadrant->canvas_item, get_canvas_item());
+  new_quadrant->canvas_item = TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_create();
+  new_quadrant->bounds = Rect2();
+  new_quadrant->edit_count = 0;
+  new_quadrant->merge_cooldown = 0;
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_set_parent(new_quadrant->canvas_item, get_canvas_item());
 
   if (material.is_valid())
-    RenderingServer::get_singleton()->canvas_item_set_material(new_quadrant->canvas_item, material->get_rid());
+    TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_set_material(new_quadrant->canvas_item, material->get_rid());
 
   return new_quadrant;
 }
 
+void TileMapper::_update_quadrant_tile_data(Quadrant *quadrant) {
+  quadrant->tile_data = _get_tile_data_from_tile_info(quadrant->tile_info);
+  if (quadrant->tile_data == nullptr)
+    return;
+
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_set_z_index(quadrant->canvas_item, quadrant->tile_data->get_z_index());
+  Ref<Material> material = quadrant->tile_data->get_material();
+  if (material.is_null())
+    material = get_material();
+
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_set_material(quadrant->canvas_item, material.is_valid() ? material->get_rid() : RID());
+}
+
 bool TileMapper::_should_draw_debug_shapes() const {
   bool debugging_collision_hint = is_inside_tree() && get_tree()->is_debugging_collisions_hint();
   return (debugging_collision_hint && collision_visibility == COLLISION_VISIBILITY_DEFAULT) || collision_visibility == COLLISION_VISIBILITY_ALWAYS;
@@ -189,7 +356,7 @@ bool TileMapper::_should_draw_debug_shapes() const {
 void TileMapper::_cell_draw_debug_shape(CellData *cell_data, const Color &shape_color) {
   for (int i = 0; i < cell_data->physics_bodies_rid.size(); i++) {
     RID body = cell_data->physics_bodies_rid[i];
-    int shape_count = PhysicsServer2D::get_singleton()->body_get_shape_count(body);
+    int shape_count = TRACE_SERVER(PhysicsServer2D::get_singleton())->body_get_shape_count(body);
 
     for (int shape_index = 0; i < shape_count; i++) {
       _draw_cell_shape(cell_data, body, shape_index, shape_color);
@@ -199,9 +366,9 @@ void TileMapper::_cell_draw_debug_shape(CellData *cell_data, const Color &shape_
 
 void TileMapper::_draw_cell_shape(CellData *cell_data, const RID &body, const int shape_index, const Color &shape_color) {
   Size2i cell_size = _get_texture_region_from_cell_data(cell_data).get_size();
-  RID shape = PhysicsServer2D::get_singleton()->body_get_shape(body, shape_index);
-  PhysicsServer2D::ShapeType shape_type = PhysicsServer2D::get_singleton()->shape_get_type(shape);
-  Transform2D shape_transform = PhysicsServer2D::get_singleton()->body_get_shape_transform(body, shape_index);
+  RID shape = TRACE_SERVER(PhysicsServer2D::get_singleton())->body_get_shape(body, shape_index);
+  PhysicsServer2D::ShapeType shape_type = TRACE_SERVER(PhysicsServer2D::get_singleton())->shape_get_type(shape);
+  Transform2D shape_transform = TRACE_SERVER(PhysicsServer2D::get_singleton())->body_get_shape_transform(body, shape_index);
 
   ERR_FAIL_COND_MSG(shape_type != PhysicsServer2D::SHAPE_CONVEX_POLYGON, "Wrong shape type for a tile, should be SHAPE_CONVEX_POLYGON.");
   RID draw_rid = _get_draw_rid_from_cell_data(cell_data);
@@ -209,42 +376,48 @@ void TileMapper::_draw_cell_shape(CellData *cell_data, const RID &body, const in
 
   PackedColorArray colors = {};
   colors.push_back(shape_color);
-  RenderingServer::get_singleton()->canvas_item_add_set_transform(draw_rid, cell_data->transform * shape_transform);
-  RenderingServer::get_singleton()->canvas_item_add_polygon(draw_rid, PhysicsServer2D::get_singleton()->shape_get_data(shape), colors);
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_add_set_transform(draw_rid, cell_data->transform * shape_transform);
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_add_polygon(draw_rid, TRACE_SERVER(PhysicsServer2D::get_singleton())->shape_get_data(shape), colors);
 }
 
 void TileMapper::_update_canvas_item_cell(CellData *cell_data) {
+  if (cell_data->tile_data == nullptr)
+    return;
+
   RenderingServer *rendering_server = RenderingServer::get_singleton();
-  rendering_server->canvas_item_set_transform(cell_data->canvas_rid, cell_data->transform);
-  rendering_server->canvas_item_set_z_index(cell_data->canvas_rid, cell_data->tile_data->get_z_index());
-  rendering_server->canvas_item_set_default_texture_filter(cell_data->canvas_rid, static_cast<RenderingServer::CanvasItemTextureFilter>(get_texture_filter()));
-  rendering_server->canvas_item_set_default_texture_repeat(cell_data->canvas_rid, static_cast<RenderingServer::CanvasItemTextureRepeat>(get_texture_repeat()));
-  rendering_server->canvas_item_set_light_mask(cell_data->canvas_rid, get_light_mask());
+  TRACE_SERVER(rendering_server)->canvas_item_set_transform(cell_data->canvas_rid, cell_data->transform);
+  TRACE_SERVER(rendering_server)->canvas_item_set_z_index(cell_data->canvas_rid, cell_data->tile_data->get_z_index());
+  TRACE_SERVER(rendering_server)->canvas_item_set_default_texture_filter(cell_data->canvas_rid, static_cast<RenderingServer::CanvasItemTextureFilter>(get_texture_filter()));
+  TRACE_SERVER(rendering_server)->canvas_item_set_default_texture_repeat(cell_data->canvas_rid, static_cast<RenderingServer::CanvasItemTextureRepeat>(get_texture_repeat()));
+  TRACE_SERVER(rendering_server)->canvas_item_set_light_mask(cell_data->canvas_rid, get_light_mask());
 }
 
 void TileMapper::_draw_tile(CellData *cell_data) {
+  if (cell_data->tile_data == nullptr || cell_data->texture.is_null())
+    return;
+
   RenderingServer *rendering_server = RenderingServer::get_singleton();
   Rect2i size_rect = _get_texture_region_from_cell_data(cell_data);
   Rect2i texture_rect = Rect2i((size_rect.position + cell_data->tile_data->get_texture_origin()), size_rect.get_size());
 
-  rendering_server->canvas_item_clear(cell_data->canvas_rid);
-  rendering_server->canvas_item_add_texture_rect_region(cell_data->canvas_rid, 
+  TRACE_SERVER(rendering_server)->canvas_item_clear(cell_data->canvas_rid);
+  TRACE_SERVER(rendering_server)->canvas_item_add_texture_rect_region(cell_data->canvas_rid, 
       texture_rect,
       cell_data->texture->get_rid(),
       size_rect);
-  rendering_server->canvas_item_set_parent(cell_data->canvas_rid, get_canvas_item());
+  TRACE_SERVER(rendering_server)->canvas_item_set_parent(cell_data->canvas_rid, get_canvas_item());
 
   Ref<Material> material = cell_data->tile_data->get_material();
   
   if (material.is_valid())
-    rendering_server->canvas_item_set_material(cell_data->canvas_rid, material->get_rid());
+    TRACE_SERVER(rendering_server)->canvas_item_set_material(cell_data->canvas_rid, material->get_rid());
 
   if (_should_draw_debug_shapes())
     _cell_draw_debug_shape(cell_data, shape_color);
 }
 
 void TileMapper::_set_cell_to_use_canvas_item_cell(CellData *cell_data) {
-  cell_data->canvas_rid = RenderingServer::get_singleton()->canvas_item_create();
+  cell_data->canvas_rid = TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_create();
   if (cell_data->current_quadrant) {
     auto iterator = cell_data->current_quadrant->cells.find(cell_data->cell_id);
     if (iterator != cell_data->current_quadrant->cells.end())
@@ -257,11 +430,15 @@ void TileMapper::_set_cell_to_use_canvas_item_cell(CellData *cell_data) {
 }
 
 void TileMapper::_set_cell_transform(CellData *cell_data, const Transform2D &new_transform) {
+  _remove_cell_from_collision_grid(cell_data);
+  _remove_cell_from_navigation(cell_data);
   cell_data->transform = new_transform;
+  _add_cell_to_collision_grid(cell_data);
+  _add_cell_to_navigation(cell_data);
 
   switch (_get_cell_draw_state(cell_data)) {
     CANVAS_ITEM:
-      RenderingServer::get_singleton()->canvas_item_set_transform(cell_data->canvas_rid, new_transform);
+      TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_set_transform(cell_data->canvas_rid, new_transform);
       break;
     QUADRANT:
       _draw_quadrant(cell_data->current_quadrant);
@@ -271,7 +448,7 @@ void TileMapper::_set_cell_transform(CellData *cell_data, const Transform2D &new
   }
 
   for (int64_t i = 0; i < cell_data->physics_bodies_rid.size(); i++)
-    PhysicsServer2D::get_singleton()->body_set_state(cell_data->physics_bodies_rid[i], PhysicsServer2D::BODY_STATE_TRANSFORM, cell_data->transform);
+    TRACE_SERVER(PhysicsServer2D::get_singleton())->body_set_state(cell_data->physics_bodies_rid[i], PhysicsServer2D::BODY_STATE_TRANSFORM, cell_data->transform);
 }
 
 void TileMapper::_general_cell_update(CellData *cell_data) {
@@ -290,9 +467,9 @@ void TileMapper::_general_cell_update(CellData *cell_data) {
 
 void TileMapper::_set_cell_to_use_quadrant(CellData *cell_data, Quadrant *quadrant) {
   if (cell_data->canvas_rid != RID())
-    RenderingServer::get_singleton()->free_rid(cell_data->canvas_rid);
+    TRACE_SERVER(RenderingServer::get_singleton())->free_rid(cell_data->canvas_rid);
   cell_data->canvas_rid = RID();
-  quadrant->cells.insert({cell_data->cell_id, cell_data});
+  _add_cell_to_quadrant(cell_data, quadrant);
   _draw_quadrant_cell(cell_data, quadrant);
 }
 
@@ -314,45 +491,86 @@ TileMapper::CellDrawState TileMapper::_get_cell_draw_state(CellData *cell_data)
 }
 
 void TileMapper::_destroy_quadrant(Quadrant *quadrant) {
-  std::vector<Quadrant*> tile_info_quadrants = {};
   auto iterator = quadrants.find(quadrant->tile_info);
   if (iterator != quadrants.end()) {
-    tile_info_quadrants = iterator->second;
-  }
-
-  if (!tile_info_quadrants.empty()) {
+    std::vector<Quadrant*> &tile_info_quadrants = iterator->second;
     auto quadrant_iterator = std::find(tile_info_quadrants.begin(), tile_info_quadrants.end(), quadrant);
-    if (quadrant_iterator != tile_info_quadrants.end()) {
+
+    if (quadrant_iterator != tile_info_quadrants.end())
       tile_info_quadrants.erase(quadrant_iterator);
-      quadrants.insert_or_assign(quadrant->tile_info, tile_info_quadrants);
-    }
+    if (tile_info_quadrants.empty())
+      quadrants.erase(iterator);
   }
 
-  RenderingServer::get_singleton()->canvas_item_clear(quadrant->canvas_item);
-  RenderingServer::get_singleton()->free_rid(quadrant->canvas_item);
+  active_quadrants.erase(quadrant);
+
+  TRACE_SERVER(RenderingServer::get_singleton())->canvas_item_clear(quadrant->canvas_item);
+  TRACE_SERVER(RenderingServer::get_singleton())->free_rid(quadrant->canvas_item);
   memdelete(quadrant);
 }
 
-void TileMapper::_destroy_quadrant_cells(Quadrant *quadrant) {
-  std::unordered_map<int64_t, CellData*> quadrant_cells = quadrant->cells;
-  for (std::pair<int64_t, CellData*> iterator: quadrant_cells) {
-    auto cell_iterator = tiles.find(iterator.first);
-    if (cell_iterator != tiles.end())
-      tiles.erase(cell_iterator);
+void TileMapper::_free_all_cells() {
+  PhysicsServer2D *physics_server2d = PhysicsServer2D::get_singleton();
+  RenderingServer *rendering_server = RenderingServer::get_singleton();
+  std::vector<RID> body_rids = {};
+  std::vector<RID> shape_rids = {};
+  std::vector<RID> canvas_rids = {};
+
+  TRACE_ZONE_NAMED(trace_zone, "_free_all_cells");
+  TRACE_ZONE_CELLS(trace_zone, tiles.size());
+  body_rids.reserve(tiles.size());
+  shape_rids.reserve(tiles.size());
+  canvas_rids.reserve(tiles.size());
+
+  for (const std::pair<const int64_t, CellData*> &iterator: tiles) {
+    CellData *cell_data = iterator.second;
+    if (cell_data->canvas_rid != RID())
+      canvas_rids.push_back(cell_data->canvas_rid);
+
+    for (int64_t i = 0; i < cell_data->physics_bodies_rid.size(); i++) {
+      RID body = cell_data->physics_bodies_rid[i];
+      int32_t shape_count = TRACE_SERVER(physics_server2d)->body_get_shape_count(body);
+
+      for (int32_t shape_index = 0; shape_index < shape_count; shape_index++)
+        shape_rids.push_back(TRACE_SERVER(physics_server2d)->body_get_shape(body, shape_index));
+      body_rids.push_back(body);
+    }
 
-    _remove_cell(iterator.second, false);
+    memdelete(cell_data);
   }
 
-  quadrant->cells.clear();
+  for (const std::pair<const TileInfo, std::vector<Quadrant*>> &iterator: quadrants) {
+    for (Quadrant *quadrant: iterator.second) {
+      canvas_rids.push_back(quadrant->canvas_item);
+      memdelete(quadrant);
+    }
+  }
+
+  tiles.clear();
+  quadrants.clear();
+  active_quadrants.clear();
+  tile_info_cells.clear();
+  collision_grid.clear();
+  collision_grid_bounds = Rect2i();
+
+  for (const std::pair<const int64_t, int32_t> &iterator: navigation_solid_counts)
+    _set_navigation_point_solid(_get_collision_grid_point(iterator.first), false);
+  navigation_solid_counts.clear();
+
+  for (const RID &body: body_rids)
+    TRACE_SERVER(physics_server2d)->free_rid(body);
+  for (const RID &shape: shape_rids)
+    TRACE_SERVER(physics_server2d)->free_rid(shape);
+  for (const RID &canvas_rid: canvas_rids)
+    TRACE_SERVER(rendering_server)->free_rid(canvas_rid);
 }
 
 void TileMapper::_remove_cell(CellData *cell_data, const bool remove_quadrant) {
   Quadrant *cell_quadrant = cell_data->current_quadrant;
-  PhysicsServer2D *physics_server2d = PhysicsServer2D::get_singleton();
   RenderingServer *rendering_server = RenderingServer::get_singleton();
 
   if (cell_data->canvas_rid != RID()) {
-    rendering_server->free_rid(cell_data->canvas_rid);
+    TRACE_SERVER(rendering_server)->free_rid(cell_data->canvas_rid);
   }
 
   if (remove_quadrant && cell_quadrant != nullptr) {
@@ -361,92 +579,634 @@ void TileMapper::_remove_cell(CellData *cell_data, const bool remove_quadrant) {
       cell_quadrant->cells.erase(cell_data->cell_id);
   }
 
-  int64_t physics_bodies_rid_size = cell_data->physics_bodies_rid.size();
+  _free_cell_physics_bodies(cell_data);
+  _remove_cell_from_collision_grid(cell_data);
+  _remove_cell_from_navigation(cell_data);
+  _unregister_cell_tile_info(cell_data);
+  memdelete(cell_data);
+}
 
-  for (int i = 0; i < physics_bodies_rid_size; i++) {
-    RID body = cell_data->physics_bodies_rid[i];
-    int32_t shape_count = physics_server2d->body_get_shape_count(body);
+void TileMapper::_register_cell_tile_info(CellData *cell_data) {
+  auto iterator = tile_info_cells.find(cell_data->tile_info);
+
+  if (iterator == tile_info_cells.end()) {
+    TileInfoCells info_cells;
+    info_cells.tile_data = cell_data->tile_data;
+    info_cells.render_state = _get_tile_render_state(cell_data->tile_info);
+    info_cells.physics_state = _get_tile_physics_state(cell_data->tile_info);
+    _cache_tile_collision_polygons(cell_data->tile_info, info_cells);
+    iterator = tile_info_cells.insert({cell_data->tile_info, info_cells}).first;
+  }
+
+  iterator->second.cells.insert({cell_data->cell_id, cell_data});
+  cell_data->info_cells = &iterator->second;
+}
+
+void TileMapper::_unregister_cell_tile_info(CellData *cell_data) {
+  auto iterator = tile_info_cells.find(cell_data->tile_info);
+  if (iterator == tile_info_cells.end())
+    return;
 
-    for (int shape_index; i < shape_count; i++) {
-      physics_server2d->free_rid(physics_server2d->body_get_shape(body, shape_index));
+  iterator->second.cells.erase(cell_data->cell_id);
+  if (iterator->second.cells.empty())
+    tile_info_cells.erase(iterator);
+}
+
+void TileMapper::_update_tile_info_cells(const TileInfo &tile_info, TileInfoCells &info_cells) {
+  TileData *tile_data = _get_tile_data_from_tile_info(tile_info);
+  Array render_state = _get_tile_render_state(tile_info);
+  Array physics_state = _get_tile_physics_state(tile_info);
+  const bool render_changed = render_state != info_cells.render_state;
+  const bool physics_changed = physics_state != info_cells.physics_state;
+
+  if (tile_data == info_cells.tile_data && !render_changed && !physics_changed)
+    return;
+
+  info_cells.tile_data = tile_data;
+  info_cells.render_state = render_state;
+  info_cells.physics_state = physics_state;
+  if (physics_changed)
+    _cache_tile_collision_polygons(tile_info, info_cells);
+
+  const bool redraw = render_changed || (physics_changed && _should_draw_debug_shapes());
+  Ref<Texture2D> texture = _get_texture_from_source_id(tile_info.source_id);
+  std::unordered_set<Quadrant*> dirty_quadrants = {};
+
+  for (std::pair<int64_t, CellData*> iterator: info_cells.cells) {
+    CellData *cell_data = iterator.second;
+    cell_data->tile_data = tile_data;
+    cell_data->texture = texture;
+
+    if (physics_changed) {
+      _free_cell_physics_bodies(cell_data);
+      cell_data->physics_bodies_rid = _create_physics_bodies_for_cell(cell_data);
+      physics_bodies_need_rebuild |= !is_inside_tree();
+      _remove_cell_from_collision_grid(cell_data);
+      _add_cell_to_collision_grid(cell_data);
+      _remove_cell_from_navigation(cell_data);
+      _add_cell_to_navigation(cell_data);
     }
 
-    physics_server2d->free_rid(body);
+    if (cell_data->current_quadrant != nullptr) {
+      dirty_quadrants.insert(cell_data->current_quadrant);
+    } else if (redraw && cell_data->canvas_rid != RID()) {
+      _draw_tile(cell_data);
+      _update_canvas_item_cell(cell_data);
+    }
   }
 
-  memdelete(cell_data);
+  for (Quadrant *quadrant: dirty_quadrants) {
+    _update_quadrant_tile_data(quadrant);
+    if (redraw)
+      _draw_quadrant(quadrant);
+  }
 }
 
-Quadrant *TileMapper::_get_quadrant_with_tile_info(TileInfo tile_info) {
-  std::vector<Quadrant*> cell_quadrants = {};
-  auto iterator = quadrants.find(tile_info);
+void TileMapper::_on_tile_set_changed() {
+  for (std::pair<const TileInfo, TileInfoCells> &iterator: tile_info_cells)
+    _update_tile_info_cells(iterator.first, iterator.second);
+}
 
-  if (iterator != quadrants.end()) {
-    cell_quadrants = iterator->second;
+static bool _is_point_in_convex_polygon(const Vector2 &point, const std::vector<Vector2> &points) {
+  real_t winding = 0;
+
+  for (size_t i = 0; i < points.size(); i++) {
+    const Vector2 &a = points[i];
+    const Vector2 &b = points[(i + 1) % points.size()];
+    real_t cross = (b - a).cross(point - a);
+
+    if (winding == 0)
+      winding = cross;
+    else if ((cross > 0 && winding < 0) || (cross < 0 && winding > 0))
+      return false;
   }
 
-  if (!cell_quadrants.empty()) {
-    Quadrant *last_quadrant = cell_quadrants.back();
-    bool new_quadrant = last_quadrant->cells.size() >= quadrant_size;
-    Quadrant *quadrant = last_quadrant->cells.size() >= quadrant_size ? _create_new_quadrant() : last_quadrant;
-    Ref<TileSetAtlasSource> source = _get_atlas_source(tile_info.source_id);
-  
-    if (last_quadrant->cells.size() <= quadrant_size && source.is_valid()) {
-      quadrant->tile_info = tile_info;
-      quadrant->tile_data = source->get_tile_data(Vector2i(tile_info.x, tile_info.y), tile_info.alternative_tile_id);
-      RenderingServer::get_singleton()->canvas_item_set_z_index(quadrant->canvas_item, quadrant->tile_data->get_z_index());
-      Ref<Material> material = quadrant->tile_data->get_material();
-      if (material.is_valid())
-        RenderingServer::get_singleton()->canvas_item_set_material(quadrant->canvas_item, material->get_rid());
+  return true;
+}
+
+void TileMapper::_cache_tile_collision_polygons(const TileInfo &tile_info, TileInfoCells &info_cells) const {
+  TileData *tile_data = _get_tile_data_from_tile_info(tile_info);
+  info_cells.collision_polygons.clear();
+  info_cells.collision_rect = Rect2();
+
+  if (tile_data == nullptr)
+    return;
+
+  Vector2 offset = _get_tile_shape_offset(tile_info);
+  bool has_rect = false;
+
+  for (int32_t layer = 0; layer < tile_set->get_physics_layers_count(); layer++) {
+    for (int32_t polygon_index = 0; polygon_index < tile_data->get_collision_polygons_count(layer); polygon_index++) {
+      PackedVector2Array points = tile_data->get_collision_polygon_points(layer, polygon_index);
+      if (points.size() <= 2)
+        continue;
+
+      TilePolygon polygon;
+      polygon.physics_layer = layer;
+      polygon.collision_layer = tile_set->get_physics_layer_collision_layer(layer);
+      polygon.points.reserve(points.size());
+
+      for (int64_t i = 0; i < points.size(); i++) {
+        Vector2 point = points[i] + offset;
+        polygon.points.push_back(point);
+
+        if (!has_rect)
+          info_cells.collision_rect = Rect2(point, Vector2());
+        else
+          info_cells.collision_rect.expand_to(point);
+        has_rect = true;
+      }
+
+      info_cells.collision_polygons.push_back(polygon);
     }
+  }
+}
+
+void TileMapper::_add_cell_to_collision_grid(CellData *cell_data) {
+  if (cell_data->info_cells == nullptr || cell_data->info_cells->collision_polygons.empty())
+    return;
+
+  Rect2 rect = cell_data->transform.xform(cell_data->info_cells->collision_rect);
+  Vector2i start = (rect.position / collision_grid_size).floor();
+  Vector2i end = (rect.get_end() / collision_grid_size).floor();
+  cell_data->collision_grid_rect = Rect2i(start, end - start + Vector2i(1, 1));
+
+  if (collision_grid.empty())
+    collision_grid_bounds = cell_data->collision_grid_rect;
+  else
+    collision_grid_bounds = collision_grid_bounds.merge(cell_data->collision_grid_rect);
+
+  for (int32_t y = start.y; y <= end.y; y++) {
+    for (int32_t x = start.x; x <= end.x; x++)
+      collision_grid[_get_collision_grid_key(x, y)].push_back(cell_data);
+  }
+}
+
+void TileMapper::_remove_cell_from_collision_grid(CellData *cell_data) {
+  Rect2i rect = cell_data->collision_grid_rect;
+
+  for (int32_t y = rect.position.y; y < rect.get_end().y; y++) {
+    for (int32_t x = rect.position.x; x < rect.get_end().x; x++) {
+      auto iterator = collision_grid.find(_get_collision_grid_key(x, y));
+      if (iterator == collision_grid.end())
+        continue;
+
+      std::vector<CellData*> &bucket = iterator->second;
+      auto cell_iterator = std::find(bucket.begin(), bucket.end(), cell_data);
+      if (cell_iterator != bucket.end()) {
+        *cell_iterator = bucket.back();
+        bucket.pop_back();
+      }
 
-    if (new_quadrant) {
-      std::vector<Quadrant*> new_cell_quadrants = cell_quadrants;
-      new_cell_quadrants.push_back(quadrant);
-      quadrants.insert_or_assign(tile_info, new_cell_quadrants);
+      if (bucket.empty())
+        collision_grid.erase(iterator);
     }
-    return quadrant;
   }
 
+  if (collision_grid.empty())
+    collision_grid_bounds = Rect2i();
+
+  cell_data->collision_grid_rect = Rect2i();
+}
+
+void TileMapper::_rebuild_collision_grid() {
+  collision_grid.clear();
+  collision_grid_bounds = Rect2i();
+
+  for (const std::pair<const int64_t, CellData*> &iterator: tiles) {
+    iterator.second->collision_grid_rect = Rect2i();
+    _add_cell_to_collision_grid(iterator.second);
+  }
+}
+
+bool TileMapper::_intersect_cell(const CellData *cell_data, const Vector2 &from, const Vector2 &to, const uint32_t layer_mask, RaycastHit &r_hit) const {
+  Transform2D inverse = cell_data->transform.affine_inverse();
+  Vector2 local_from = inverse.xform(from);
+  Vector2 local_to = inverse.xform(to);
+  Vector2 direction = local_to - local_from;
+  bool hit = false;
+
+  for (const TilePolygon &polygon: cell_data->info_cells->collision_polygons) {
+    // Like PhysicsDirectSpaceState2D, shapes containing the ray origin are not reported.
+    if ((polygon.collision_layer & layer_mask) == 0 || _is_point_in_convex_polygon(local_from, polygon.points))
+      continue;
+
+    for (size_t i = 0; i < polygon.points.size(); i++) {
+      const Vector2 &a = polygon.points[i];
+      Vector2 edge = polygon.points[(i + 1) % polygon.points.size()] - a;
+      real_t denominator = direction.cross(edge);
+      if (Math::is_zero_approx(denominator))
+        continue;
+
+      real_t fraction = (a - local_from).cross(edge) / denominator;
+      real_t edge_fraction = (a - local_from).cross(direction) / denominator;
+      if (fraction < 0 || fraction > 1 || edge_fraction < 0 || edge_fraction > 1 || fraction >= r_hit.fraction)
+        continue;
+
+      Vector2 normal = Vector2(edge.y, -edge.x);
+      if (normal.dot(direction) > 0)
+        normal = -normal;
+
+      r_hit.fraction = fraction;
+      r_hit.normal = cell_data->transform.basis_xform(normal).normalized();
+      r_hit.cell_data = const_cast<CellData*>(cell_data);
+      r_hit.physics_layer = polygon.physics_layer;
+      hit = true;
+    }
+  }
+
+  return hit;
+}
+
+bool TileMapper::_intersect_segment(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask, RaycastHit &r_hit) const {
+  r_hit.fraction = Math_INF;
+  r_hit.cell_data = nullptr;
+  ERR_FAIL_COND_V(!from.is_finite() || !to.is_finite(), false);
+
+  const Vector2 delta = to - from;
+  if (collision_grid.empty() || delta.is_zero_approx())
+    return false;
+
+  // Clip the segment to the occupied buckets (Liang-Barsky) so empty space around the cells is never walked.
+  const real_t grid_size = collision_grid_size;
+  const Vector2 bounds_start = Vector2(collision_grid_bounds.position) * grid_size;
+  const Vector2 bounds_end = Vector2(collision_grid_bounds.get_end()) * grid_size;
+  real_t enter_fraction = 0;
+  real_t leave_fraction = 1;
+
+  for (int axis = 0; axis < 2; axis++) {
+    if (Math::is_zero_approx(delta[axis])) {
+      if (from[axis] < bounds_start[axis] || from[axis] > bounds_end[axis])
+        return false;
+      continue;
+    }
+
+    real_t start_fraction = (bounds_start[axis] - from[axis]) / delta[axis];
+    real_t end_fraction = (bounds_end[axis] - from[axis]) / delta[axis];
+    enter_fraction = MAX(enter_fraction, MIN(start_fraction, end_fraction));
+    leave_fraction = MIN(leave_fraction, MAX(start_fraction, end_fraction));
+  }
+
+  if (enter_fraction > leave_fraction)
+    return false;
+
+  const Vector2i last_bucket = collision_grid_bounds.get_end() - Vector2i(1, 1);
+  Vector2i bucket = Vector2i(((from + delta * enter_fraction) / grid_size).floor()).clamp(collision_grid_bounds.position, last_bucket);
+  const Vector2i end_bucket = Vector2i(((from + delta * leave_fraction) / grid_size).floor()).clamp(collision_grid_bounds.position, last_bucket);
+  const Vector2i step = Vector2i(delta.x > 0 ? 1 : -1, delta.y > 0 ? 1 : -1);
+  Vector2 next_fraction = Vector2(Math_INF, Math_INF);
+  Vector2 fraction_step = Vector2(Math_INF, Math_INF);
+
+  if (!Math::is_zero_approx(delta.x)) {
+    next_fraction.x = ((bucket.x + (step.x > 0 ? 1 : 0)) * grid_size - from.x) / delta.x;
+    fraction_step.x = grid_size / Math::abs(delta.x);
+  }
+  if (!Math::is_zero_approx(delta.y)) {
+    next_fraction.y = ((bucket.y + (step.y > 0 ? 1 : 0)) * grid_size - from.y) / delta.y;
+    fraction_step.y = grid_size / Math::abs(delta.y);
+  }
+
+  while (true) {
+    auto iterator = collision_grid.find(_get_collision_grid_key(bucket.x, bucket.y));
+    if (iterator != collision_grid.end()) {
+      for (const CellData *cell_data: iterator->second)
+        _intersect_cell(cell_data, from, to, layer_mask, r_hit);
+    }
+
+    const real_t exit_fraction = MIN(next_fraction.x, next_fraction.y);
+    if (r_hit.fraction <= exit_fraction || exit_fraction > leave_fraction || bucket == end_bucket)
+      break;
+
+    if (next_fraction.x < next_fraction.y) {
+      bucket.x += step.x;
+      next_fraction.x += fraction_step.x;
+    } else {
+      bucket.y += step.y;
+      next_fraction.y += fraction_step.y;
+    }
+  }
+
+  return r_hit.cell_data != nullptr;
+}
+
+Dictionary TileMapper::_get_raycast_hit_dictionary(const Vector2 &from, const Vector2 &to, const RaycastHit &hit) const {
+  Dictionary data = {};
+  data["position"] = from + (to - from) * hit.fraction;
+  data["normal"] = hit.normal;
+  data["cell_id"] = hit.cell_data->cell_id;
+  data["physics_layer"] = hit.physics_layer;
+  return data;
+}
+
+bool TileMapper::_is_cell_navigation_solid(CellData *cell_data) const {
+  if (cell_data->info_cells == nullptr)
+    return false;
+
+  for (const TilePolygon &polygon: cell_data->info_cells->collision_polygons) {
+    if (polygon.physics_layer == navigation_physics_layer)
+      return true;
+  }
+  return false;
+}
+
+void TileMapper::_set_navigation_point_solid(const Vector2i &point, const bool solid) {
+  if (navigation_grid.is_null() || navigation_grid->is_dirty() || !navigation_grid->is_in_boundsv(point))
+    return;
+  navigation_grid->set_point_solid(point, solid);
+}
+
+// Several cells can cover the same grid point, so a point only changes solidity when its first cell arrives or its last one leaves.
+void TileMapper::_add_cell_to_navigation(CellData *cell_data) {
+  if (navigation_grid.is_null() || !_is_cell_navigation_solid(cell_data))
+    return;
+
+  Vector2 center = cell_data->transform.xform(cell_data->info_cells->collision_rect).get_center();
+  Vector2i point = ((center - navigation_grid->get_offset()) / navigation_grid->get_cell_size()).floor();
+  int32_t &count = navigation_solid_counts[_get_collision_grid_key(point.x, point.y)];
+
+  cell_data->navigation_solid = true;
+  cell_data->navigation_point = point;
+  count++;
+  if (count == 1)
+    _set_navigation_point_solid(point, true);
+}
+
+void TileMapper::_remove_cell_from_navigation(CellData *cell_data) {
+  if (!cell_data->navigation_solid)
+    return;
+
+  cell_data->navigation_solid = false;
+  auto iterator = navigation_solid_counts.find(_get_collision_grid_key(cell_data->navigation_point.x, cell_data->navigation_point.y));
+  if (iterator == navigation_solid_counts.end())
+    return;
+
+  iterator->second--;
+  if (iterator->second <= 0) {
+    navigation_solid_counts.erase(iterator);
+    _set_navigation_point_solid(cell_data->navigation_point, false);
+  }
+}
+
+void TileMapper::_clear_navigation() {
+  for (const std::pair<const int64_t, CellData*> &iterator: tiles)
+    _remove_cell_from_navigation(iterator.second);
+  navigation_solid_counts.clear();
+}
+
+Quadrant *TileMapper::_get_quadrant_with_tile_info(TileInfo tile_info) {
+  std::vector<Quadrant*> &cell_quadrants = quadrants[tile_info];
+
+  if (!cell_quadrants.empty() && cell_quadrants.back()->cells.size() < quadrant_size)
+    return cell_quadrants.back();
+
   Quadrant *new_quadrant = _create_new_quadrant();
-  std::vector<Quadrant*> new_quadrant_vector = {new_quadrant};
-  quadrants.insert({tile_info, new_quadrant_vector});
+  new_quadrant->tile_info = tile_info;
+  _update_quadrant_tile_data(new_quadrant);
+  cell_quadrants.push_back(new_quadrant);
   return new_quadrant;
 }
 
-void TileMapper::_create_new_cell(const Vector2 &coords, const int32_t source_id, const Vector2i &atlas_coords, const int alternative_tile_id) {
-  ERR_FAIL_COND_MSG(tile_set.is_null(), "Tried adding cell with no TileSet.");
-  ERR_FAIL_COND_MSG(!tile_set->has_source(source_id), vformat("TileSet source with id %s does not exist.", source_id));
-  Ref<TileSetAtlasSource> source = _get_atlas_source(source_id);
+void TileMapper::_mark_quadrant_edited(Quadrant *quadrant) {
+  quadrant->edit_count++;
+  active_quadrants.insert(quadrant);
+}
 
-  ERR_FAIL_COND_MSG(source.is_null(), vformat("Tile source with id %s is not a TileSetAtlasSource.", source_id));
-  ERR_FAIL_COND_MSG(!source->has_tile(atlas_coords), vformat("No tile at %s.", atlas_coords));
-  ERR_FAIL_COND_MSG(!source->has_alternative_tile(atlas_coords, alternative_tile_id), vformat(""));
+void TileMapper::_add_cell_to_quadrant(CellData *cell_data, Quadrant *quadrant) {
+  Vector2 origin = cell_data->transform.get_origin();
+  if (quadrant->cells.empty())
+    quadrant->bounds = Rect2(origin, Vector2());
+  else
+    quadrant->bounds.expand_to(origin);
 
-  CellData *cell_data = memnew(CellData);
-  int64_t cell_id = index;
+  quadrant->cells.insert({cell_data->cell_id, cell_data});
+  cell_data->current_quadrant = quadrant;
+}
+
+Quadrant *TileMapper::_split_quadrant(Quadrant *quadrant) {
+  std::vector<CellData*> cells = {};
+  cells.reserve(quadrant->cells.size());
+
+  for (std::pair<int64_t, CellData*> iterator: quadrant->cells)
+    cells.push_back(iterator.second);
+
+  const int axis = quadrant->bounds.size.x >= quadrant->bounds.size.y ? 0 : 1;
+  auto middle = cells.begin() + cells.size() / 2;
+  std::nth_element(cells.begin(), middle, cells.end(), [axis](CellData *left, CellData *right) {
+    return left->transform.get_origin()[axis] < right->transform.get_origin()[axis];
+  });
+
+  Quadrant *new_quadrant = _create_new_quadrant();
+  new_quadrant->tile_info = quadrant->tile_info;
+  _update_quadrant_tile_data(new_quadrant);
+
+  quadrant->cells.clear();
+  for (auto iterator = cells.begin(); iterator != cells.end(); iterator++)
+    _add_cell_to_quadrant(*iterator, iterator < middle ? quadrant : new_quadrant);
+
+  // Both halves stay unmergeable until edits stop for QUADRANT_MERGE_COOLDOWN passes, otherwise they would be merged straight back.
+  quadrant->edit_count = 0;
+  quadrant->merge_cooldown = QUADRANT_MERGE_COOLDOWN;
+  new_quadrant->merge_cooldown = QUADRANT_MERGE_COOLDOWN;
+  return new_quadrant;
+}
+
+size_t TileMapper::_merge_quadrant_with_neighbours(Quadrant *quadrant, std::unordered_set<Quadrant*> &dirty_quadrants) {
+  if (quadrant->cells.empty() || quadrant->cells.size() * 4 > quadrant_size)
+    return 0;
+
+  std::vector<Quadrant*> &tile_info_quadrants = quadrants[quadrant->tile_info];
+  const Vector2 tile_size = Vector2(_get_texture_region_from_atlas_source(quadrant->tile_info.source_id, Vector2i(quadrant->tile_info.x, quadrant->tile_info.y)).get_size());
+  const Vector2 max_extent = tile_size * Math::ceil(Math::sqrt(real_t(quadrant_size)));
+  size_t work = 0;
+
+  while (true) {
+    Quadrant *nearest = nullptr;
+    real_t nearest_distance = 0;
+
+    for (Quadrant *other: tile_info_quadrants) {
+      work++;
+      if (other == quadrant || other->edit_count != 0 || other->merge_cooldown != 0 || (quadrant->cells.size() + other->cells.size()) * 2 > quadrant_size)
+        continue;
+
+      Rect2 merged_bounds = quadrant->bounds.merge(other->bounds);
+      if (merged_bounds.size.x > max_extent.x || merged_bounds.size.y > max_extent.y)
+        continue;
+
+      real_t distance = quadrant->bounds.get_center().distance_squared_to(other->bounds.get_center());
+      if (nearest == nullptr || distance < nearest_distance) {
+        nearest = other;
+        nearest_distance = distance;
+      }
+    }
+
+    if (nearest == nullptr)
+      break;
+
+    for (std::pair<int64_t, CellData*> iterator: nearest->cells)
+      _add_cell_to_quadrant(iterator.second, quadrant);
+
+    dirty_quadrants.insert(quadrant);
+    dirty_quadrants.erase(nearest);
+    active_quadrants.erase(nearest);
+    tile_info_quadrants.erase(std::find(tile_info_quadrants.begin(), tile_info_quadrants.end(), nearest));
+    TRACE_SERVER(RenderingServer::get_singleton())->free_rid(nearest->canvas_item);
+    memdelete(nearest);
+  }
+
+  return work;
+}
+
+void TileMapper::_compact_quadrants() {
+  TRACE_ZONE("_compact_quadrants");
+  std::unordered_set<Quadrant*> dirty_quadrants = {};
+  std::vector<Quadrant*> pending_quadrants = {};
+  size_t work = 0;
+
+  while (!active_quadrants.empty() && work < QUADRANT_COMPACTION_BUDGET) {
+    Quadrant *quadrant = *active_quadrants.begin();
+    active_quadrants.erase(active_quadrants.begin());
+    work++;
+
+    if (quadrant->edit_count >= QUADRANT_SPLIT_EDIT_COUNT && quadrant->cells.size() >= QUADRANT_MIN_SPLIT_CELLS) {
+      Quadrant *new_quadrant = _split_quadrant(quadrant);
+      quadrants[quadrant->tile_info].push_back(new_quadrant);
+      dirty_quadrants.insert(quadrant);
+      dirty_quadrants.insert(new_quadrant);
+      pending_quadrants.push_back(new_quadrant);
+    }
+
+    quadrant->edit_count /= 2;
+    if (quadrant->edit_count == 0 && quadrant->merge_cooldown > 0)
+      quadrant->merge_cooldown--;
+
+    if (quadrant->edit_count == 0 && quadrant->merge_cooldown == 0)
+      work += _merge_quadrant_with_neighbours(quadrant, dirty_quadrants);
+    else
+      pending_quadrants.push_back(quadrant);
+  }
+
+  active_quadrants.insert(pending_quadrants.begin(), pending_quadrants.end());
+  for (Quadrant *quadrant: dirty_quadrants)
+    _draw_quadrant(quadrant);
+}
+
+bool TileMapper::_validate_tile_info(const TileInfo &tile_info) const {
+  const Vector2i atlas_coords = Vector2i(tile_info.x, tile_info.y);
+  ERR_FAIL_COND_V_MSG(tile_set.is_null(), false, "Tried adding cell with no TileSet.");
+  ERR_FAIL_COND_V_MSG(!tile_set->has_source(tile_info.source_id), false, vformat("TileSet source with id %s does not exist.", tile_info.source_id));
+  Ref<TileSetAtlasSource> source = _get_atlas_source(tile_info.source_id);
+
+  ERR_FAIL_COND_V_MSG(source.is_null(), false, vformat("Tile source with id %s is not a TileSetAtlasSource.", tile_info.source_id));
+  ERR_FAIL_COND_V_MSG(!source->has_tile(atlas_coords), false, vformat("No tile at %s.", atlas_coords));
+  ERR_FAIL_COND_V_MSG(!source->has_alternative_tile(atlas_coords, tile_info.alternative_tile_id), false, vformat("No alternative tile with id %s at %s.", tile_info.alternative_tile_id, atlas_coords));
+  return true;
+}
+
+bool TileMapper::_get_tile_info_from_variant(const Variant &value, TileInfo &r_tile_info) const {
+  ERR_FAIL_COND_V_MSG(value.get_type() != Variant::DICTIONARY, false, "Tile description must be a Dictionary.");
+  Dictionary description = value;
+
+  ERR_FAIL_COND_V_MSG(!description.has("source_id"), false, "Tile description is missing \"source_id\".");
+  Vector2i atlas_coords = description.get("atlas_coords", Vector2i());
+  r_tile_info.x = atlas_coords.x;
+  r_tile_info.y = atlas_coords.y;
+  r_tile_info.source_id = description["source_id"];
+  r_tile_info.alternative_tile_id = description.get("alternative_tile_id", 0);
+  return true;
+}
+
+void TileMapper::_create_new_cell(const Vector2 &coords, const int32_t source_id, const Vector2i &atlas_coords, const int alternative_tile_id) {
+  TRACE_ZONE("_create_new_cell");
   TileInfo tile_info;
   tile_info.x = atlas_coords.x;
   tile_info.y = atlas_coords.y;
   tile_info.source_id = source_id;
   tile_info.alternative_tile_id = alternative_tile_id;
 
+  if (!_validate_tile_info(tile_info))
+    return;
+
+  _create_cell_from_tile_info(coords, tile_info, _get_tile_data_from_tile_info(tile_info), _get_texture_from_source_id(source_id));
+}
+
+void TileMapper::_create_cell_from_tile_info(const Vector2 &coords, const TileInfo &tile_info, TileData *tile_data, const Ref<Texture2D> &texture) {
+  TRACE_ZONE("_create_cell_from_tile_info");
+  CellData *cell_data = memnew(CellData);
+  int64_t cell_id = index;
+
   cell_data->cell_id = cell_id;
-  cell_data->texture = _get_texture_from_source_id(source_id);
+  cell_data->texture = texture;
   cell_data->tile_info = tile_info;
   cell_data->transform = Transform2D(0, coords);
-  cell_data->tile_data = source->get_tile_data(atlas_coords, alternative_tile_id);
+  cell_data->tile_data = tile_data;
   cell_data->physics_bodies_rid = _create_physics_bodies_for_cell(cell_data);
+  physics_bodies_need_rebuild |= !is_inside_tree();
+  cell_data->info_cells = nullptr;
+  cell_data->navigation_solid = false;
 
   Quadrant *quadrant = _get_quadrant_with_tile_info(tile_info);
 
-  quadrant->cells.insert({cell_id, cell_data});
+  _add_cell_to_quadrant(cell_data, quadrant);
   tiles.insert({cell_id, cell_data});
-
-  cell_data->current_quadrant = quadrant;
+  _register_cell_tile_info(cell_data);
+  _add_cell_to_collision_grid(cell_data);
+  _add_cell_to_navigation(cell_data);
   _draw_quadrant_cell(cell_data, quadrant);
 }
 
+int64_t TileMapper::_add_cell_from_tile_info(const Vector2 &coords, const TileInfo &tile_info, TileData *tile_data, const Ref<Texture2D> &texture) {
+  if (index == INVALID_TILE_ID)
+    index++;
+
+  int64_t cell_id = index;
+  _create_cell_from_tile_info(coords, tile_info, tile_data, texture);
+
+  index++;
+  return cell_id;
+}
+
+PackedInt64Array TileMapper::_fill_from_indices(const uint8_t *indices, const int64_t width, const int64_t height, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile) {
+  TileInfo palette_tile_infos[256];
+  TileData *palette_tile_datas[256] = {};
+  Ref<Texture2D> palette_textures[256];
+  Array palette_indices = palette_to_tile.keys();
+
+  for (int64_t i = 0; i < palette_indices.size(); i++) {
+    const Variant palette_index = palette_indices[i];
+    ERR_CONTINUE_MSG(palette_index.get_type() != Variant::INT, "Palette keys must be integers.");
+    const int64_t palette_value = palette_index;
+    ERR_CONTINUE_MSG(palette_value <= 0 || palette_value > 255, vformat("Palette index %s is out of range, expected 1-255.", palette_value));
+
+    TileInfo tile_info;
+    if (!_get_tile_info_from_variant(palette_to_tile[palette_index], tile_info) || !_validate_tile_info(tile_info))
+      continue;
+
+    palette_tile_infos[palette_value] = tile_info;
+    palette_tile_datas[palette_value] = _get_tile_data_from_tile_info(tile_info);
+    palette_textures[palette_value] = _get_texture_from_source_id(tile_info.source_id);
+  }
+
+  TRACE_ZONE_NAMED(trace_zone, "_fill_from_indices");
+  std::vector<int64_t> cell_ids = {};
+  for (int64_t y = 0; y < height; y++) {
+    const uint8_t *row = indices + y * width;
+
+    for (int64_t x = 0; x < width; x++) {
+      const uint8_t palette_value = row[x];
+      if (palette_tile_datas[palette_value] == nullptr)
+        continue;
+
+      Vector2 coords = origin + Vector2(x, y) * cell_size;
+      cell_ids.push_back(_add_cell_from_tile_info(coords, palette_tile_infos[palette_value], palette_tile_datas[palette_value], palette_textures[palette_value]));
+    }
+  }
+
+  TRACE_ZONE_CELLS(trace_zone, cell_ids.size());
+  PackedInt64Array result = {};
+  result.resize(cell_ids.size());
+  std::copy(cell_ids.begin(), cell_ids.end(), result.ptrw());
+  return result;
+}
 
 int64_t TileMapper::add_cell(const Vector2 &coords, const int32_t source_id, const Vector2i &atlas_coords, const int alternative_tile_id) {
   if (index == INVALID_TILE_ID)
@@ -465,10 +1225,15 @@ bool TileMapper::destroy_cell(const int64_t cell_id) {
     CellData *cell_data = iterator->second;
     Quadrant *quadrant = cell_data->current_quadrant;
 
-    if (quadrant != nullptr && quadrant->cells.size() == 1)
-      _destroy_quadrant(quadrant);
-
+    tiles.erase(iterator);
     _remove_cell(cell_data);
+
+    if (quadrant != nullptr && quadrant->cells.empty()) {
+      _destroy_quadrant(quadrant);
+    } else if (quadrant != nullptr) {
+      _mark_quadrant_edited(quadrant);
+      _draw_quadrant(quadrant);
+    }
     return true;
   }
 
@@ -476,21 +1241,61 @@ bool TileMapper::destroy_cell(const int64_t cell_id) {
 }
 
 void TileMapper::clear_cells() {
-  std::unordered_map<TileInfo, std::vector<Quadrant*>> local_quadrants = quadrants;
-  std::unordered_map<int64_t, CellData*> local_tiles = tiles;
-  
-  for (auto iterator: local_quadrants) {
-    std::vector<Quadrant*> local_local_quadrants = iterator.second;
-    for (Quadrant *quadrant: local_local_quadrants) {
-      _destroy_quadrant_cells(quadrant);
-      _destroy_quadrant(quadrant);
+  TRACE_ZONE_NAMED(trace_zone, "clear_cells");
+  TRACE_ZONE_CELLS(trace_zone, tiles.size());
+  _free_all_cells();
+}
+
+PackedInt64Array TileMapper::fill_rect(const Rect2i &rect, const Vector2 &origin, const Vector2 &cell_size, const int32_t source_id, const Vector2i &atlas_coords, const int alternative_tile_id) {
+  PackedInt64Array cell_ids = {};
+  TileInfo tile_info;
+  tile_info.x = atlas_coords.x;
+  tile_info.y = atlas_coords.y;
+  tile_info.source_id = source_id;
+  tile_info.alternative_tile_id = alternative_tile_id;
+
+  ERR_FAIL_COND_V_MSG(!rect.has_area(), cell_ids, "Tried filling an empty rect.");
+  if (!_validate_tile_info(tile_info))
+    return cell_ids;
+
+  TileData *tile_data = _get_tile_data_from_tile_info(tile_info);
+  Ref<Texture2D> texture = _get_texture_from_source_id(source_id);
+  int64_t i = 0;
+
+  cell_ids.resize(int64_t(rect.size.x) * rect.size.y);
+  int64_t *cell_ids_ptr = cell_ids.ptrw();
+  TRACE_ZONE_NAMED(trace_zone, "fill_rect");
+  TRACE_ZONE_CELLS(trace_zone, cell_ids.size());
+
+  for (int32_t y = rect.position.y; y < rect.get_end().y; y++) {
+    for (int32_t x = rect.position.x; x < rect.get_end().x; x++) {
+      cell_ids_ptr[i] = _add_cell_from_tile_info(origin + Vector2(x, y) * cell_size, tile_info, tile_data, texture);
+      i++;
     }
   }
 
-  tiles.clear();
-  quadrants.clear();
-  UtilityFunctions::print(tiles.size());
-  UtilityFunctions::print(quadrants.size());
+  return cell_ids;
+}
+
+PackedInt64Array TileMapper::fill_from_image(const Ref<Image> &image, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile) {
+  ERR_FAIL_COND_V_MSG(image.is_null() || image->is_empty(), PackedInt64Array(), "Tried filling cells from an empty Image.");
+  ERR_FAIL_COND_V_MSG(image->is_compressed(), PackedInt64Array(), "Tried filling cells from a compressed Image.");
+  Ref<Image> index_image = image;
+
+  // Palette indices are read from the red channel, one byte per cell.
+  if (image->get_format() != Image::FORMAT_R8 && image->get_format() != Image::FORMAT_L8) {
+    index_image = image->duplicate();
+    index_image->convert(Image::FORMAT_R8);
+  }
+
+  PackedByteArray data = index_image->get_data();
+  return _fill_from_indices(data.ptr(), index_image->get_width(), index_image->get_height(), origin, cell_size, palette_to_tile);
+}
+
+PackedInt64Array TileMapper::fill_from_bytes(const PackedByteArray &data, const int64_t width, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile) {
+  ERR_FAIL_COND_V_MSG(width <= 0, PackedInt64Array(), "Width must be greater than 0.");
+  ERR_FAIL_COND_V_MSG(data.size() % width != 0, PackedInt64Array(), vformat("Data size %s is not a multiple of width %s.", data.size(), width));
+  return _fill_from_indices(data.ptr(), width, data.size() / width, origin, cell_size, palette_to_tile);
 }
 
 bool TileMapper::is_cell_id_valid(const int64_t cell_id) const {
@@ -529,9 +1334,84 @@ Dictionary TileMapper::get_cell_values(const int64_t cell_id) const {
   return data;
 }
 
+Dictionary TileMapper::raycast(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask) const {
+  RaycastHit hit;
+  if (!_intersect_segment(from, to, layer_mask, hit))
+    return Dictionary();
+  return _get_raycast_hit_dictionary(from, to, hit);
+}
+
+bool TileMapper::has_line_of_sight(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask) const {
+  RaycastHit hit;
+  return !_intersect_segment(from, to, layer_mask, hit);
+}
+
+Array TileMapper::raycast_batch(const PackedVector2Array &segments, const uint32_t layer_mask) const {
+  Array results = {};
+  ERR_FAIL_COND_V_MSG(segments.size() % 2 != 0, results, "Segments must be given as from/to pairs.");
+
+  const Vector2 *points = segments.ptr();
+  results.resize(segments.size() / 2);
+
+  for (int64_t i = 0; i < results.size(); i++) {
+    RaycastHit hit;
+    const Vector2 &from = points[i * 2];
+    const Vector2 &to = points[i * 2 + 1];
+    results[i] = _intersect_segment(from, to, layer_mask, hit) ? _get_raycast_hit_dictionary(from, to, hit) : Dictionary();
+  }
+
+  return results;
+}
+
+PackedByteArray TileMapper::has_line_of_sight_batch(const PackedVector2Array &segments, const uint32_t layer_mask) const {
+  PackedByteArray results = {};
+  ERR_FAIL_COND_V_MSG(segments.size() % 2 != 0, results, "Segments must be given as from/to pairs.");
+
+  const Vector2 *points = segments.ptr();
+  results.resize(segments.size() / 2);
+  uint8_t *results_ptr = results.ptrw();
+
+  for (int64_t i = 0; i < results.size(); i++) {
+    RaycastHit hit;
+    results_ptr[i] = !_intersect_segment(points[i * 2], points[i * 2 + 1], layer_mask, hit);
+  }
+
+  return results;
+}
+
+#ifdef TILE_MAPPER_TRACING
+Error TileMapper::dump_trace(const String &path) const {
+  return tracing::dump(path);
+}
+#endif
+
+void TileMapper::sync_navigation_grid() {
+  _clear_navigation();
+  if (navigation_grid.is_null())
+    return;
+
+  if (navigation_grid->is_dirty())
+    navigation_grid->update();
+
+  for (const std::pair<const int64_t, CellData*> &iterator: tiles)
+    _add_cell_to_navigation(iterator.second);
+}
+
 
 void TileMapper::set_tile_set(Ref<TileSet> new_tile_set) {
+  if (tile_set == new_tile_set)
+    return;
+
+  Callable changed_callable = Callable(this, "_on_tile_set_changed");
+  if (tile_set.is_valid() && tile_set->is_connected("changed", changed_callable))
+    tile_set->disconnect("changed", changed_callable);
+
   tile_set = new_tile_set;
+
+  if (tile_set.is_valid())
+    tile_set->connect("changed", changed_callable);
+
+  _on_tile_set_changed();
 }
 
 Ref<TileSet> TileMapper::get_tile_set() const {
@@ -554,6 +1434,15 @@ int TileMapper::get_quadrant_size() const {
   return quadrant_size;
 }
 
+void TileMapper::set_adaptive_quadrants(const bool new_adaptive_quadrants) {
+  adaptive_quadrants = new_adaptive_quadrants;
+  set_process(adaptive_quadrants);
+}
+
+bool TileMapper::get_adaptive_quadrants() const {
+  return adaptive_quadrants;
+}
+
 void TileMapper::set_collision_visibility(const int new_collision_visibility) {
   collision_visibility = new_collision_visibility;
 }
@@ -561,3 +1450,35 @@ void TileMapper::set_collision_visibility(const int new_collision_visibility) {
 int TileMapper::get_collision_visibility() const {
   return collision_visibility;
 }
+
+void TileMapper::set_collision_grid_size(const int new_collision_grid_size) {
+  ERR_FAIL_COND_MSG(new_collision_grid_size <= 0, "Collision grid size must be greater than 0.");
+  if (collision_grid_size == new_collision_grid_size)
+    return;
+
+  collision_grid_size = new_collision_grid_size;
+  _rebuild_collision_grid();
+}
+
+int TileMapper::get_collision_grid_size() const {
+  return collision_grid_size;
+}
+
+void TileMapper::set_navigation_grid(const Ref<AStarGrid2D> new_navigation_grid) {
+  _clear_navigation();
+  navigation_grid = new_navigation_grid;
+  sync_navigation_grid();
+}
+
+Ref<AStarGrid2D> TileMapper::get_navigation_grid() const {
+  return navigation_grid;
+}
+
+void TileMapper::set_navigation_physics_layer(const int new_navigation_physics_layer) {
+  navigation_physics_layer = new_navigation_physics_layer;
+  sync_navigation_grid();
+}
+
+int TileMapper::get_navigation_physics_layer() const {
+  return navigation_physics_layer;
+}
@@ -4,11 +4,16 @@
 #include "godot_cpp/classes/project_settings.hpp"
 #include "quadrant.hpp"
 #include "cell_data.hpp"
+#include "tracing.hpp"
 
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/a_star_grid2d.hpp>
 #include <godot_cpp/classes/node2d.hpp>
 #include <godot_cpp/classes/physics_server2d.hpp>
 #include <godot_cpp/classes/tile_set_atlas_source.hpp>
 
+#include <unordered_set>
+
 
 namespace godot {
 
@@ -17,6 +22,13 @@ struct ShapeData {
   real_t margin;
 };
 
+struct RaycastHit {
+  real_t fraction;
+  Vector2 normal;
+  CellData *cell_data;
+  int32_t physics_layer;
+};
+
 class TileMapper : public Node2D {
 GDCLASS(TileMapper, Node2D);
 
@@ -33,26 +45,47 @@ private:
     COLLISION_VISIBILITY_NONE = 2,
   };
 
+  static constexpr uint32_t QUADRANT_SPLIT_EDIT_COUNT = 8;
+  static constexpr size_t QUADRANT_MIN_SPLIT_CELLS = 8;
+  static constexpr uint32_t QUADRANT_MERGE_COOLDOWN = 8;
+  static constexpr size_t QUADRANT_COMPACTION_BUDGET = 1024;
+
   const Color shape_color = ProjectSettings::get_singleton()->get_setting("debug/shapes/collision/shape_color", Color());
 
   Ref<TileSet> tile_set;
   PhysicsServer2D::BodyMode collision_type;
   int quadrant_size;
+  bool adaptive_quadrants;
+  bool physics_bodies_need_rebuild;
   int collision_visibility;
+  int collision_grid_size;
+  Ref<AStarGrid2D> navigation_grid;
+  int navigation_physics_layer;
 
   int64_t index;
   
   std::unordered_map<TileInfo, std::vector<Quadrant*>> quadrants;
   std::unordered_map<int64_t, CellData*> tiles;
+  std::unordered_set<Quadrant*> active_quadrants;
+  std::unordered_map<TileInfo, TileInfoCells> tile_info_cells;
+  std::unordered_map<int64_t, std::vector<CellData*>> collision_grid;
+  Rect2i collision_grid_bounds;
+  std::unordered_map<int64_t, int32_t> navigation_solid_counts;
 
   Ref<TileSetAtlasSource> _get_atlas_source(const int32_t source_id) const;
   Ref<Texture2D> _get_texture_from_source_id(const int32_t source_id) const;
   Rect2i _get_texture_region_from_atlas_source(const int32_t source_id, const Vector2i &atlas_coords) const;
   Rect2i _get_texture_region_from_cell_data(CellData *cell_data) const;
+  Vector2 _get_tile_shape_offset(const TileInfo &tile_info) const;
+  TileData *_get_tile_data_from_tile_info(const TileInfo &tile_info) const;
+  Array _get_tile_render_state(const TileInfo &tile_info) const;
+  Array _get_tile_physics_state(const TileInfo &tile_info) const;
   
   RID _create_shape_for_cell_layer_polygon_index(CellData *cell_data, const int32_t layer, const int32_t polygon_index) const;
   RID _create_cell_body_for_layer(CellData *cell_data, const int32_t layer) const;
   TypedArray<RID> _create_physics_bodies_for_cell(CellData *cell_data) const;
+  void _free_cell_physics_bodies(CellData *cell_data);
+  void _rebuild_physics_bodies();
 
   void _draw_quadrant(Quadrant *quadrant);
   void _draw_quadrant_cell(CellData *cell_data, Quadrant *quadrant);
@@ -69,15 +102,46 @@ private:
   RID _get_draw_rid_from_cell_data(CellData *cell_data) const;
   CellDrawState _get_cell_draw_state(CellData *cell_data) const;
   void _destroy_quadrant(Quadrant *quadrant);
-  void _destroy_quadrant_cells(Quadrant *quadrant);
+  void _free_all_cells();
   void _remove_cell(CellData *cell_data, const bool remove_quadrant = true);
 
+  void _register_cell_tile_info(CellData *cell_data);
+  void _unregister_cell_tile_info(CellData *cell_data);
+  void _update_tile_info_cells(const TileInfo &tile_info, TileInfoCells &info_cells);
+  void _on_tile_set_changed();
+
+  void _cache_tile_collision_polygons(const TileInfo &tile_info, TileInfoCells &info_cells) const;
+  void _add_cell_to_collision_grid(CellData *cell_data);
+  void _remove_cell_from_collision_grid(CellData *cell_data);
+  void _rebuild_collision_grid();
+  bool _intersect_cell(const CellData *cell_data, const Vector2 &from, const Vector2 &to, const uint32_t layer_mask, RaycastHit &r_hit) const;
+  bool _intersect_segment(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask, RaycastHit &r_hit) const;
+  Dictionary _get_raycast_hit_dictionary(const Vector2 &from, const Vector2 &to, const RaycastHit &hit) const;
+
+  bool _is_cell_navigation_solid(CellData *cell_data) const;
+  void _set_navigation_point_solid(const Vector2i &point, const bool solid);
+  void _add_cell_to_navigation(CellData *cell_data);
+  void _remove_cell_from_navigation(CellData *cell_data);
+  void _clear_navigation();
+
   Quadrant *_create_new_quadrant() const;
+  void _update_quadrant_tile_data(Quadrant *quadrant);
   Quadrant *_get_quadrant_with_tile_info(TileInfo tile_info);
+  void _mark_quadrant_edited(Quadrant *quadrant);
+  void _add_cell_to_quadrant(CellData *cell_data, Quadrant *quadrant);
+  Quadrant *_split_quadrant(Quadrant *quadrant);
+  size_t _merge_quadrant_with_neighbours(Quadrant *quadrant, std::unordered_set<Quadrant*> &dirty_quadrants);
+  void _compact_quadrants();
+  bool _validate_tile_info(const TileInfo &tile_info) const;
+  bool _get_tile_info_from_variant(const Variant &value, TileInfo &r_tile_info) const;
   void _create_new_cell(const Vector2 &coords, const int32_t source_id, const Vector2i &atlas_coords = Vector2i(), const int alternative_tile_id = 0);
+  void _create_cell_from_tile_info(const Vector2 &coords, const TileInfo &tile_info, TileData *tile_data, const Ref<Texture2D> &texture);
+  int64_t _add_cell_from_tile_info(const Vector2 &coords, const TileInfo &tile_info, TileData *tile_data, const Ref<Texture2D> &texture);
+  PackedInt64Array _fill_from_indices(const uint8_t *indices, const int64_t width, const int64_t height, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile);
 
 protected:
   static void _bind_methods();
+  void _notification(int what);
  
 public:
   TileMapper();
@@ -88,10 +152,22 @@ public:
   int64_t add_cell(const Vector2 &coords, const int32_t source_id, const Vector2i &atlas_coords = Vector2i(), const int alternative_tile_id = 0);
   bool destroy_cell(const int64_t cell_id);
   void clear_cells();
+  PackedInt64Array fill_rect(const Rect2i &rect, const Vector2 &origin, const Vector2 &cell_size, const int32_t source_id, const Vector2i &atlas_coords = Vector2i(), const int alternative_tile_id = 0);
+  PackedInt64Array fill_from_image(const Ref<Image> &image, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile);
+  PackedInt64Array fill_from_bytes(const PackedByteArray &data, const int64_t width, const Vector2 &origin, const Vector2 &cell_size, const Dictionary &palette_to_tile);
   bool is_cell_id_valid(const int64_t cell_id) const;
   PackedInt64Array get_used_tile_ids() const;
   Dictionary get_cell_values(const int64_t cell_id) const;
 
+  Dictionary raycast(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask = 0xFFFFFFFF) const;
+  bool has_line_of_sight(const Vector2 &from, const Vector2 &to, const uint32_t layer_mask = 0xFFFFFFFF) const;
+  Array raycast_batch(const PackedVector2Array &segments, const uint32_t layer_mask = 0xFFFFFFFF) const;
+  PackedByteArray has_line_of_sight_batch(const PackedVector2Array &segments, const uint32_t layer_mask = 0xFFFFFFFF) const;
+  void sync_navigation_grid();
+#ifdef TILE_MAPPER_TRACING
+  Error dump_trace(const String &path) const;
+#endif
+
   void set_tile_set(const Ref<TileSet> new_tile_set);
   Ref<TileSet> get_tile_set() const;
 
@@ -101,8 +177,20 @@ public:
   void set_quadrant_size(const int new_quadrant_size);
   int get_quadrant_size() const;
 
+  void set_adaptive_quadrants(const bool new_adaptive_quadrants);
+  bool get_adaptive_quadrants() const;
+
   void set_collision_visibility(const int new_collision_visibility);
   int get_collision_visibility() const;
+
+  void set_collision_grid_size(const int new_collision_grid_size);
+  int get_collision_grid_size() const;
+
+  void set_navigation_grid(const Ref<AStarGrid2D> new_navigation_grid);
+  Ref<AStarGrid2D> get_navigation_grid() const;
+
+  void set_navigation_physics_layer(const int new_navigation_physics_layer);
+  int get_navigation_physics_layer() const;
 };
 
 }
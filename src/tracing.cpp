@@ -0,0 +1,64 @@
+#include "tracing.hpp"
+
+#ifdef TILE_MAPPER_TRACING
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include <godot_cpp/classes/file_access.hpp>
+
+using namespace godot;
+
+thread_local uint64_t tracing::server_calls = 0;
+
+static tracing::TraceEvent trace_events[tracing::TRACE_BUFFER_SIZE];
+static std::atomic<uint64_t> trace_write_index = 0;
+
+uint64_t tracing::now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writers only claim a slot, so recording never blocks. Once full, the oldest events are overwritten.
+void tracing::record(const TraceEvent &event) {
+  uint64_t slot = trace_write_index.fetch_add(1, std::memory_order_relaxed);
+  trace_events[slot & (TRACE_BUFFER_SIZE - 1)] = event;
+}
+
+Error tracing::dump(const String &path) {
+  Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+  ERR_FAIL_COND_V_MSG(file.is_null(), FileAccess::get_open_error(), vformat("Could not open trace file %s.", path));
+
+  const uint64_t end = trace_write_index.load(std::memory_order_acquire);
+  const uint64_t begin = end > TRACE_BUFFER_SIZE ? end - TRACE_BUFFER_SIZE : 0;
+  PackedStringArray lines = {};
+
+  for (uint64_t i = begin; i < end; i++) {
+    const TraceEvent &event = trace_events[i & (TRACE_BUFFER_SIZE - 1)];
+    lines.push_back(vformat("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%d,\"dur\":%d,\"args\":{\"cells\":%d,\"server_calls\":%d}}",
+        event.name, int64_t(event.thread_id), int64_t(event.start_us), int64_t(event.duration_us), event.cell_count, int64_t(event.server_calls)));
+  }
+
+  file->store_string("{\"traceEvents\":[\n" + String(",\n").join(lines) + "\n]}\n");
+  return OK;
+}
+
+tracing::TraceZone::TraceZone(const char *name) {
+  event.name = name;
+  event.thread_id = std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xFFFFFFFF;
+  event.cell_count = 0;
+  server_calls_start = server_calls;
+  event.start_us = now_us();
+}
+
+tracing::TraceZone::~TraceZone() {
+  event.duration_us = now_us() - event.start_us;
+  event.server_calls = server_calls - server_calls_start;
+  record(event);
+}
+
+void tracing::TraceZone::set_cell_count(const int64_t cell_count) {
+  event.cell_count = cell_count;
+}
+
+#endif // TILE_MAPPER_TRACING
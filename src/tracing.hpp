@@ -0,0 +1,68 @@
+#ifndef TILE_MAPPER_TRACING_ZONES
+#define TILE_MAPPER_TRACING_ZONES
+
+// Hot path tracing, only compiled in with `scons tracing=yes`.
+// Zones are recorded into a fixed size ring buffer and written out as Chrome trace events by TileMapper::dump_trace.
+
+#ifdef TILE_MAPPER_TRACING
+
+#include <atomic>
+#include <cstdint>
+
+#include <godot_cpp/classes/global_constants.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+namespace godot {
+
+namespace tracing {
+
+struct TraceEvent {
+  const char *name;
+  uint64_t start_us;
+  uint64_t duration_us;
+  uint64_t thread_id;
+  int64_t cell_count;
+  uint64_t server_calls;
+};
+
+constexpr uint64_t TRACE_BUFFER_SIZE = 1 << 16;
+
+extern thread_local uint64_t server_calls;
+
+uint64_t now_us();
+void record(const TraceEvent &event);
+Error dump(const String &path);
+
+class TraceZone {
+  TraceEvent event;
+  uint64_t server_calls_start;
+
+public:
+  TraceZone(const char *name);
+  ~TraceZone();
+
+  void set_cell_count(const int64_t cell_count);
+};
+
+}
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) godot::tracing::TraceZone TRACE_CONCAT(_trace_zone_, __LINE__)(name)
+#define TRACE_ZONE_NAMED(variable, name) godot::tracing::TraceZone variable(name)
+#define TRACE_ZONE_CELLS(variable, count) variable.set_cell_count(count)
+// Wraps the server a call is made on, counting the call at the call site: TRACE_SERVER(rendering_server)->free_rid(rid).
+#define TRACE_SERVER(server) (godot::tracing::server_calls++, (server))
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_ZONE_NAMED(variable, name)
+#define TRACE_ZONE_CELLS(variable, count)
+#define TRACE_SERVER(server) (server)
+
+#endif // TILE_MAPPER_TRACING
+
+#endif // !TILE_MAPPER_TRACING_ZONES